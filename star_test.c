@@ -0,0 +1,577 @@
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "starpack.h"
+
+// Pruebas de libstarpack. Devuelve 0 si todas pasan.
+
+#define READER_THREADS 8
+#define READS_PER_THREAD 4000
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FALLO %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static char archive_path[64];
+
+static unsigned char *make_content(size_t size, unsigned seed) {
+    unsigned char *data = malloc(size > 0 ? size : 1);
+    for (size_t i = 0; i < size; i++) {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = (unsigned char)(seed >> 16);
+    }
+    return data;
+}
+
+static FILE *make_input(const unsigned char *data, size_t size) {
+    FILE *input = tmpfile();
+    fwrite(data, 1, size, input);
+    rewind(input);
+    return input;
+}
+
+static StarStatus append_content(StarArchive *archive, const char *name, const unsigned char *data, size_t size) {
+    FILE *input = make_input(data, size);
+    StarStatus status = star_append(archive, name, input);
+    fclose(input);
+    return status;
+}
+
+static StarStatus update_content(StarArchive *archive, const char *name, const unsigned char *data, size_t size) {
+    FILE *input = make_input(data, size);
+    StarStatus status = star_update(archive, name, input);
+    fclose(input);
+    return status;
+}
+
+static bool content_matches(StarArchive *archive, const char *name, const unsigned char *data, size_t size) {
+    StarEntryInfo info;
+    if (star_stat(archive, name, &info) != STAR_OK || info.size != size) {
+        return false;
+    }
+
+    unsigned char *buffer = malloc(size + 1);
+    size_t bytes_read;
+    StarStatus status = star_read(archive, name, 0, buffer, size + 1, &bytes_read);
+    bool same = status == STAR_OK && bytes_read == size && memcmp(buffer, data, size) == 0;
+    free(buffer);
+    return same;
+}
+
+static StarArchive *create_archive(size_t cache_blocks) {
+    StarOptions options;
+    star_default_options(&options);
+    options.cache_blocks = cache_blocks;
+    StarArchive *archive = NULL;
+    CHECK(star_create(archive_path, &options, &archive) == STAR_OK);
+    return archive;
+}
+
+static StarArchive *reopen_archive(StarArchive *archive) {
+    star_close(archive);
+    StarArchive *reopened = NULL;
+    CHECK(star_open(archive_path, NULL, &reopened) == STAR_OK);
+    return reopened;
+}
+
+// ---------------------------------------------------------------------------
+// Lecturas concurrentes contra un escritor
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    StarArchive *archive;
+    const unsigned char *data;
+    size_t size;
+    unsigned seed;
+    int errors;
+} ReaderArgs;
+
+static void *reader_thread(void *arg) {
+    ReaderArgs *args = arg;
+    unsigned char *buffer = malloc(STAR_BLOCK_SIZE + 1024);
+
+    for (int i = 0; i < READS_PER_THREAD; i++) {
+        size_t offset = (size_t)rand_r(&args->seed) % args->size;
+        size_t count = (size_t)rand_r(&args->seed) % (STAR_BLOCK_SIZE + 1024);
+        size_t expected = count < args->size - offset ? count : args->size - offset;
+        size_t bytes_read;
+
+        if (star_read(args->archive, "fijo", offset, buffer, count, &bytes_read) != STAR_OK ||
+            bytes_read != expected ||
+            memcmp(buffer, args->data + offset, bytes_read) != 0) {
+            args->errors++;
+        }
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+typedef struct {
+    StarArchive *archive;
+    atomic_bool *stop;
+    int errors;
+} WriterArgs;
+
+static void *writer_thread(void *arg) {
+    WriterArgs *args = arg;
+    unsigned char *first = make_content(3 * STAR_BLOCK_SIZE + 17, 7);
+    unsigned char *second = make_content(STAR_BLOCK_SIZE / 2, 8);
+
+    // Los bloques de "temporal" se liberan y reutilizan sin parar, así
+    // que una caché que no se invalide devolvería datos ajenos.
+    while (!atomic_load(args->stop)) {
+        if (append_content(args->archive, "temporal", first, 3 * STAR_BLOCK_SIZE + 17) != STAR_OK) args->errors++;
+        if (update_content(args->archive, "temporal", second, STAR_BLOCK_SIZE / 2) != STAR_OK) args->errors++;
+        if (star_delete(args->archive, "temporal") != STAR_OK) args->errors++;
+    }
+
+    free(first);
+    free(second);
+    return NULL;
+}
+
+static void test_concurrent_reads(void) {
+    size_t size = 5 * STAR_BLOCK_SIZE + 123;
+    unsigned char *data = make_content(size, 1);
+
+    // Dos ranuras para forzar desalojos, cargas duplicadas y lecturas
+    // directas cuando todas están fijadas
+    StarArchive *archive = create_archive(2);
+    CHECK(append_content(archive, "fijo", data, size) == STAR_OK);
+
+    atomic_bool stop = false;
+    WriterArgs writer = { archive, &stop, 0 };
+    ReaderArgs readers[READER_THREADS];
+    pthread_t writer_id;
+    pthread_t reader_ids[READER_THREADS];
+
+    pthread_create(&writer_id, NULL, writer_thread, &writer);
+    for (int i = 0; i < READER_THREADS; i++) {
+        readers[i] = (ReaderArgs){ archive, data, size, (unsigned)i + 1, 0 };
+        pthread_create(&reader_ids[i], NULL, reader_thread, &readers[i]);
+    }
+    for (int i = 0; i < READER_THREADS; i++) {
+        pthread_join(reader_ids[i], NULL);
+        CHECK(readers[i].errors == 0);
+    }
+    atomic_store(&stop, true);
+    pthread_join(writer_id, NULL);
+    CHECK(writer.errors == 0);
+
+    archive = reopen_archive(archive);
+    CHECK(content_matches(archive, "fijo", data, size));
+    star_close(archive);
+    free(data);
+}
+
+static void test_cache_invalidation(void) {
+    size_t size = 2 * STAR_BLOCK_SIZE + 9;
+    unsigned char *old_data = make_content(size, 50);
+    unsigned char *new_data = make_content(size, 51);
+
+    // Los bloques de "viejo" quedan en caché y "nuevo" los reutiliza
+    StarArchive *archive = create_archive(4);
+    CHECK(append_content(archive, "viejo", old_data, size) == STAR_OK);
+    CHECK(content_matches(archive, "viejo", old_data, size));
+    CHECK(star_delete(archive, "viejo") == STAR_OK);
+    CHECK(append_content(archive, "nuevo", new_data, size) == STAR_OK);
+    CHECK(content_matches(archive, "nuevo", new_data, size));
+
+    CHECK(update_content(archive, "nuevo", old_data, size) == STAR_OK);
+    CHECK(content_matches(archive, "nuevo", old_data, size));
+
+    star_close(archive);
+    free(old_data);
+    free(new_data);
+}
+
+static void sleep_ms(long milliseconds) {
+    struct timespec delay = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+    nanosleep(&delay, NULL);
+}
+
+typedef struct {
+    StarArchive *archive;
+    FILE *input;
+    StarStatus status;
+} SlowAppendArgs;
+
+static void *slow_append_thread(void *arg) {
+    SlowAppendArgs *args = arg;
+    args->status = star_append(args->archive, "lento", args->input);
+    return NULL;
+}
+
+typedef struct {
+    StarArchive *archive;
+    const unsigned char *data;
+    size_t size;
+    atomic_bool done;
+    bool matches;
+} BlockedReadArgs;
+
+static void *blocked_read_thread(void *arg) {
+    BlockedReadArgs *args = arg;
+    args->matches = content_matches(args->archive, "fijo", args->data, args->size);
+    atomic_store(&args->done, true);
+    return NULL;
+}
+
+static void test_slow_append_does_not_block_reads(void) {
+    size_t size = STAR_BLOCK_SIZE + 7;
+    unsigned char *data = make_content(size, 60);
+    unsigned char *slow = make_content(size, 61);
+
+    StarArchive *archive = create_archive(2);
+    CHECK(append_content(archive, "fijo", data, size) == STAR_OK);
+
+    // El productor escribe la mitad y se queda esperando; mientras tanto
+    // una lectura sobre otra entrada debe completarse.
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    SlowAppendArgs appender = { archive, fdopen(fds[0], "rb"), STAR_OK };
+    pthread_t appender_id;
+    pthread_create(&appender_id, NULL, slow_append_thread, &appender);
+    CHECK(write(fds[1], slow, size / 2) == (ssize_t)(size / 2));
+    sleep_ms(100);
+
+    BlockedReadArgs reader = { archive, data, size, false, false };
+    pthread_t reader_id;
+    pthread_create(&reader_id, NULL, blocked_read_thread, &reader);
+    for (int i = 0; i < 500 && !atomic_load(&reader.done); i++) {
+        sleep_ms(10);
+    }
+    CHECK(atomic_load(&reader.done));
+
+    CHECK(write(fds[1], slow + size / 2, size - size / 2) == (ssize_t)(size - size / 2));
+    close(fds[1]);
+    pthread_join(reader_id, NULL);
+    pthread_join(appender_id, NULL);
+    fclose(appender.input);
+
+    CHECK(reader.matches);
+    CHECK(appender.status == STAR_OK);
+    CHECK(content_matches(archive, "lento", slow, size));
+
+    star_close(archive);
+    free(data);
+    free(slow);
+}
+
+// ---------------------------------------------------------------------------
+// Desfragmentación tras borrados y actualizaciones intercaladas
+// ---------------------------------------------------------------------------
+
+static const char *pack_names[] = { "a", "b", "c", "d" };
+
+// Deja "b", "d" y "c" con bloques desordenados; "a" queda borrado
+static StarArchive *create_scrambled_archive(unsigned char *data[4], size_t sizes[4]) {
+    size_t initial[] = { 2 * STAR_BLOCK_SIZE + 5, STAR_BLOCK_SIZE, 3 * STAR_BLOCK_SIZE, 10 };
+    for (int i = 0; i < 4; i++) {
+        sizes[i] = initial[i];
+        data[i] = make_content(sizes[i], (unsigned)i + 100);
+    }
+
+    StarArchive *archive = create_archive(4);
+    for (int i = 0; i < 3; i++) {
+        CHECK(append_content(archive, pack_names[i], data[i], sizes[i]) == STAR_OK);
+    }
+
+    // La actualización de "b" toma los bloques de "a" en orden inverso y
+    // "d" y "c" ocupan los que "b" libera, así las entradas quedan
+    // desordenadas y star_pack tiene que intercambiar bloques.
+    CHECK(star_delete(archive, "a") == STAR_OK);
+    free(data[1]);
+    sizes[1] = 4 * STAR_BLOCK_SIZE + 1;
+    data[1] = make_content(sizes[1], 200);
+    CHECK(update_content(archive, "b", data[1], sizes[1]) == STAR_OK);
+    CHECK(append_content(archive, "d", data[3], sizes[3]) == STAR_OK);
+    CHECK(star_delete(archive, "c") == STAR_OK);
+    CHECK(append_content(archive, "c", data[2], sizes[2]) == STAR_OK);
+    return archive;
+}
+
+static void test_pack_after_mutations(void) {
+    const char **names = pack_names;
+    unsigned char *data[4];
+    size_t sizes[4];
+    StarArchive *archive = create_scrambled_archive(data, sizes);
+
+    // Con la caché llena de posiciones anteriores a la compactación
+    for (int i = 1; i < 4; i++) {
+        CHECK(content_matches(archive, names[i], data[i], sizes[i]));
+    }
+    CHECK(star_pack(archive) == STAR_OK);
+
+    size_t used_blocks = 0;
+    for (int i = 1; i < 4; i++) {
+        CHECK(content_matches(archive, names[i], data[i], sizes[i]));
+        StarEntryInfo info;
+        CHECK(star_stat(archive, names[i], &info) == STAR_OK);
+        used_blocks += info.block_count;
+    }
+
+    archive = reopen_archive(archive);
+    for (int i = 1; i < 4; i++) {
+        CHECK(content_matches(archive, names[i], data[i], sizes[i]));
+    }
+
+    // Tras compactar los bloques quedan contiguos y el archivo no tiene sobrante
+    StarEntryInfo first;
+    CHECK(star_stat(archive, "b", &first) == STAR_OK);
+    size_t table_size = first.block_indices[0];
+    FILE *packed = fopen(archive_path, "rb");
+    fseek(packed, 0, SEEK_END);
+    CHECK((size_t)ftell(packed) == table_size + used_blocks * STAR_BLOCK_SIZE);
+    fclose(packed);
+
+    // El archivo compactado admite nuevas escrituras
+    CHECK(append_content(archive, "a", data[0], sizes[0]) == STAR_OK);
+    CHECK(content_matches(archive, "a", data[0], sizes[0]));
+
+    star_close(archive);
+    for (int i = 0; i < 4; i++) {
+        free(data[i]);
+    }
+}
+
+// Se enlaza con -Wl,--wrap=pwrite: la escritura número pwrite_countdown
+// falla con EIO.
+static int pwrite_countdown = 0;
+
+ssize_t __real_pwrite(int fd, const void *buf, size_t count, off_t offset);
+
+ssize_t __wrap_pwrite(int fd, const void *buf, size_t count, off_t offset) {
+    if (pwrite_countdown > 0 && --pwrite_countdown == 0) {
+        errno = EIO;
+        return -1;
+    }
+    return __real_pwrite(fd, buf, count, offset);
+}
+
+static void test_pack_write_failures(void) {
+    // Se hace fallar cada escritura de star_pack por turno. Sea cual sea
+    // el punto de fallo, el archivo debe reabrirse con todo su contenido.
+    bool completed = false;
+    for (int failing_write = 1; !completed && failing_write < 1000; failing_write++) {
+        unsigned char *data[4];
+        size_t sizes[4];
+        StarArchive *archive = create_scrambled_archive(data, sizes);
+
+        pwrite_countdown = failing_write;
+        StarStatus status = star_pack(archive);
+        completed = pwrite_countdown > 0;
+        pwrite_countdown = 0;
+        CHECK(status == (completed ? STAR_OK : STAR_ERR_IO));
+
+        for (int i = 1; i < 4; i++) {
+            CHECK(content_matches(archive, pack_names[i], data[i], sizes[i]));
+        }
+        archive = reopen_archive(archive);
+        for (int i = 1; i < 4; i++) {
+            CHECK(content_matches(archive, pack_names[i], data[i], sizes[i]));
+        }
+
+        // Un archivo interrumpido sigue admitiendo escrituras y otra compactación
+        CHECK(append_content(archive, "a", data[0], sizes[0]) == STAR_OK);
+        CHECK(star_pack(archive) == STAR_OK);
+        CHECK(content_matches(archive, "a", data[0], sizes[0]));
+        for (int i = 1; i < 4; i++) {
+            CHECK(content_matches(archive, pack_names[i], data[i], sizes[i]));
+        }
+
+        star_close(archive);
+        for (int i = 0; i < 4; i++) {
+            free(data[i]);
+        }
+    }
+    CHECK(completed);
+}
+
+// ---------------------------------------------------------------------------
+// Nombres duplicados y límites de la tabla
+// ---------------------------------------------------------------------------
+
+static void test_duplicate_append(void) {
+    unsigned char *original = make_content(1000, 300);
+    unsigned char *other = make_content(2000, 301);
+
+    StarArchive *archive = create_archive(0);
+    CHECK(append_content(archive, "dup", original, 1000) == STAR_OK);
+    CHECK(append_content(archive, "dup", other, 2000) == STAR_ERR_EXISTS);
+    CHECK(content_matches(archive, "dup", original, 1000));
+
+    archive = reopen_archive(archive);
+    CHECK(content_matches(archive, "dup", original, 1000));
+
+    star_close(archive);
+    free(original);
+    free(other);
+}
+
+static void test_table_limits(void) {
+    size_t too_big = STAR_MAX_BLOCKS_PER_ENTRY * (size_t)STAR_BLOCK_SIZE + 1;
+    unsigned char *big = make_content(too_big, 400);
+    unsigned char *small = make_content(10, 401);
+
+    StarArchive *archive = create_archive(0);
+    CHECK(append_content(archive, "base", small, 10) == STAR_OK);
+    CHECK(append_content(archive, "grande", big, too_big) == STAR_ERR_FULL);
+    StarEntryInfo info;
+    CHECK(star_stat(archive, "grande", &info) == STAR_ERR_NOT_FOUND);
+    CHECK(update_content(archive, "base", big, too_big) == STAR_ERR_FULL);
+    CHECK(content_matches(archive, "base", small, 10));
+
+    // Los bloques del intento fallido vuelven a la lista de libres
+    CHECK(append_content(archive, "justo", big, too_big - 1) == STAR_OK);
+    CHECK(content_matches(archive, "justo", big, too_big - 1));
+
+    char name[32];
+    for (int i = 2; i < STAR_MAX_ENTRIES; i++) {
+        snprintf(name, sizeof(name), "e%d", i);
+        CHECK(append_content(archive, name, small, 10) == STAR_OK);
+    }
+    CHECK(append_content(archive, "sobra", small, 10) == STAR_ERR_FULL);
+
+    archive = reopen_archive(archive);
+    CHECK(content_matches(archive, "base", small, 10));
+    CHECK(content_matches(archive, "justo", big, too_big - 1));
+
+    star_close(archive);
+    free(big);
+    free(small);
+}
+
+// ---------------------------------------------------------------------------
+// Archivos dañados y opciones inválidas
+// ---------------------------------------------------------------------------
+
+static void test_damaged_archive(void) {
+    size_t size = 3 * STAR_BLOCK_SIZE;
+    unsigned char *data = make_content(size, 500);
+
+    StarArchive *archive = create_archive(0);
+    CHECK(append_content(archive, "x", data, size) == STAR_OK);
+    star_close(archive);
+
+    // Un bloque usado que no cabe en el archivo se rechaza al abrir
+    CHECK(truncate(archive_path, (off_t)(size + 1000)) == 0);
+    archive = NULL;
+    CHECK(star_open(archive_path, NULL, &archive) == STAR_ERR_FORMAT);
+    CHECK(archive == NULL);
+
+    StarOptions options;
+    star_default_options(&options);
+    options.cache_blocks = (size_t)STAR_MAX_CACHE_BLOCKS + 1;
+    CHECK(star_create(archive_path, &options, &archive) == STAR_ERR_INVALID);
+
+    free(data);
+}
+
+// ---------------------------------------------------------------------------
+// Exclusión entre manejadores
+// ---------------------------------------------------------------------------
+
+static void test_handle_locking(void) {
+    size_t size = STAR_BLOCK_SIZE + 3;
+    unsigned char *data = make_content(size, 600);
+    StarArchive *archive = create_archive(0);
+    CHECK(append_content(archive, "x", data, size) == STAR_OK);
+    star_close(archive);
+
+    // Cada star_open usa su propio descriptor, así que los bloqueos se
+    // comportan igual que entre procesos distintos
+    StarOptions read_only;
+    star_default_options(&read_only);
+    read_only.read_only = true;
+    StarArchive *first = NULL;
+    StarArchive *second = NULL;
+    StarArchive *writer = NULL;
+    CHECK(star_open(archive_path, &read_only, &first) == STAR_OK);
+    CHECK(star_open(archive_path, &read_only, &second) == STAR_OK);
+    CHECK(star_open(archive_path, NULL, &writer) == STAR_ERR_BUSY);
+    CHECK(writer == NULL);
+
+    // Un star_create bloqueado no debe vaciar el archivo de los lectores
+    CHECK(star_create(archive_path, NULL, &writer) == STAR_ERR_BUSY);
+    CHECK(content_matches(first, "x", data, size));
+    star_close(first);
+    star_close(second);
+
+    CHECK(star_open(archive_path, NULL, &writer) == STAR_OK);
+    CHECK(star_open(archive_path, &read_only, &first) == STAR_ERR_BUSY);
+    CHECK(star_open(archive_path, NULL, &second) == STAR_ERR_BUSY);
+    star_close(writer);
+
+    CHECK(star_open(archive_path, &read_only, &first) == STAR_OK);
+    CHECK(content_matches(first, "x", data, size));
+    star_close(first);
+    free(data);
+}
+
+static void count_message(const char *message, void *ctx) {
+    if (message[0] != '\0') {
+        (*(int *)ctx)++;
+    }
+}
+
+static void test_log_callback(void) {
+    unsigned char *data = make_content(2 * STAR_BLOCK_SIZE, 700);
+    int messages = 0;
+
+    StarOptions options;
+    star_default_options(&options);
+    options.log = count_message;
+    options.log_ctx = &messages;
+    StarArchive *archive = NULL;
+    CHECK(star_create(archive_path, &options, &archive) == STAR_OK);
+
+    // Un mensaje por bloque escrito y por bloque liberado
+    CHECK(append_content(archive, "x", data, 2 * STAR_BLOCK_SIZE) == STAR_OK);
+    int after_append = messages;
+    CHECK(after_append >= 2);
+    CHECK(star_delete(archive, "x") == STAR_OK);
+    CHECK(messages == after_append + 2);
+
+    star_close(archive);
+    free(data);
+}
+
+int main(void) {
+    snprintf(archive_path, sizeof(archive_path), "star_test_%ld.tar", (long)getpid());
+
+    test_concurrent_reads();
+    test_cache_invalidation();
+    test_slow_append_does_not_block_reads();
+    test_pack_after_mutations();
+    test_pack_write_failures();
+    test_duplicate_append();
+    test_table_limits();
+    test_damaged_archive();
+    test_handle_locking();
+    test_log_callback();
+
+    unlink(archive_path);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d comprobaciones fallaron.\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("Todas las pruebas pasaron.\n");
+    return EXIT_SUCCESS;
+}
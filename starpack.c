@@ -0,0 +1,1011 @@
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+
+#include "starpack.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TOTAL_BLOCKS (STAR_MAX_BLOCKS_PER_ENTRY * STAR_MAX_ENTRIES)
+#define NO_BLOCK ((size_t)-1)
+
+typedef struct {
+    char name[STAR_MAX_NAME_LENGTH];
+    size_t size;
+    size_t block_indices[STAR_MAX_BLOCKS_PER_ENTRY];
+    size_t block_count;
+} Entry;
+
+typedef struct {
+    Entry entries[STAR_MAX_ENTRIES];
+    size_t entry_count;
+    size_t free_block_indices[TOTAL_BLOCKS];
+    size_t free_block_count;
+} FileAllocationTable;
+
+typedef struct {
+    unsigned char content[STAR_BLOCK_SIZE];
+} DataBlock;
+
+// Un bloque en caché. Los índices prev/next forman la lista LRU (head es el
+// más reciente) y hash_next la cadena de su cubeta.
+typedef struct {
+    size_t offset;
+    bool valid;
+    unsigned pins;
+    int prev;
+    int next;
+    int hash_next;
+    DataBlock *data;
+} CacheSlot;
+
+typedef struct {
+    pthread_mutex_t lock;
+    CacheSlot *slots;
+    size_t capacity;
+    int *buckets;
+    size_t bucket_mask;
+    int head;
+    int tail;
+} BlockCache;
+
+struct StarArchive {
+    int fd;
+    StarOptions options;
+    pthread_rwlock_t fat_lock;
+    FileAllocationTable fat;
+    BlockCache cache;
+    DataBlock *scratch; // Dos bloques de trabajo para las escrituras
+};
+
+// ---------------------------------------------------------------------------
+// E/S con desplazamiento explícito
+// ---------------------------------------------------------------------------
+
+static StarStatus read_fully(int fd, void *buf, size_t count, size_t offset) {
+    unsigned char *dst = buf;
+    while (count > 0) {
+        ssize_t n = pread(fd, dst, count, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return STAR_ERR_IO;
+        }
+        if (n == 0) {
+            // Todo bloque usado se escribe completo: llegar al final del
+            // archivo significa que está truncado o dañado
+            return STAR_ERR_FORMAT;
+        }
+        dst += n;
+        offset += (size_t)n;
+        count -= (size_t)n;
+    }
+    return STAR_OK;
+}
+
+static StarStatus write_fully(int fd, const void *buf, size_t count, size_t offset) {
+    const unsigned char *src = buf;
+    while (count > 0) {
+        ssize_t n = pwrite(fd, src, count, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return STAR_ERR_IO;
+        }
+        src += n;
+        offset += (size_t)n;
+        count -= (size_t)n;
+    }
+    return STAR_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Caché LRU de bloques
+// ---------------------------------------------------------------------------
+
+static StarStatus cache_init(BlockCache *cache, size_t capacity) {
+    memset(cache, 0, sizeof(BlockCache));
+    cache->head = -1;
+    cache->tail = -1;
+    if (pthread_mutex_init(&cache->lock, NULL) != 0) {
+        return STAR_ERR_NO_MEMORY;
+    }
+    if (capacity == 0) {
+        return STAR_OK;
+    }
+
+    size_t bucket_count = 1;
+    while (bucket_count < capacity * 2) {
+        bucket_count <<= 1;
+    }
+
+    cache->slots = calloc(capacity, sizeof(CacheSlot));
+    cache->buckets = malloc(bucket_count * sizeof(int));
+    if (cache->slots == NULL || cache->buckets == NULL) {
+        free(cache->slots);
+        free(cache->buckets);
+        pthread_mutex_destroy(&cache->lock);
+        return STAR_ERR_NO_MEMORY;
+    }
+    for (size_t i = 0; i < bucket_count; i++) {
+        cache->buckets[i] = -1;
+    }
+    cache->bucket_mask = bucket_count - 1;
+    cache->capacity = capacity;
+
+    // Todas las ranuras empiezan vacías, encadenadas en la lista LRU
+    for (size_t i = 0; i < capacity; i++) {
+        cache->slots[i].prev = (int)i - 1;
+        cache->slots[i].next = (i + 1 < capacity) ? (int)i + 1 : -1;
+        cache->slots[i].hash_next = -1;
+    }
+    cache->head = 0;
+    cache->tail = (int)capacity - 1;
+    return STAR_OK;
+}
+
+static void cache_destroy(BlockCache *cache) {
+    for (size_t i = 0; i < cache->capacity; i++) {
+        free(cache->slots[i].data);
+    }
+    free(cache->slots);
+    free(cache->buckets);
+    pthread_mutex_destroy(&cache->lock);
+}
+
+static size_t cache_bucket(const BlockCache *cache, size_t offset) {
+    return (offset / STAR_BLOCK_SIZE) & cache->bucket_mask;
+}
+
+static int cache_find(const BlockCache *cache, size_t offset) {
+    for (int i = cache->buckets[cache_bucket(cache, offset)]; i != -1; i = cache->slots[i].hash_next) {
+        if (cache->slots[i].offset == offset) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void cache_hash_insert(BlockCache *cache, int slot) {
+    size_t bucket = cache_bucket(cache, cache->slots[slot].offset);
+    cache->slots[slot].hash_next = cache->buckets[bucket];
+    cache->buckets[bucket] = slot;
+    cache->slots[slot].valid = true;
+}
+
+static void cache_hash_remove(BlockCache *cache, int slot) {
+    if (!cache->slots[slot].valid) return;
+
+    int *link = &cache->buckets[cache_bucket(cache, cache->slots[slot].offset)];
+    while (*link != slot) {
+        link = &cache->slots[*link].hash_next;
+    }
+    *link = cache->slots[slot].hash_next;
+    cache->slots[slot].hash_next = -1;
+    cache->slots[slot].valid = false;
+}
+
+static void cache_unlink(BlockCache *cache, int slot) {
+    CacheSlot *s = &cache->slots[slot];
+    if (s->prev != -1) cache->slots[s->prev].next = s->next; else cache->head = s->next;
+    if (s->next != -1) cache->slots[s->next].prev = s->prev; else cache->tail = s->prev;
+    s->prev = -1;
+    s->next = -1;
+}
+
+static void cache_push_front(BlockCache *cache, int slot) {
+    cache_unlink(cache, slot);
+    cache->slots[slot].next = cache->head;
+    if (cache->head != -1) cache->slots[cache->head].prev = slot; else cache->tail = slot;
+    cache->head = slot;
+}
+
+static void cache_push_back(BlockCache *cache, int slot) {
+    cache_unlink(cache, slot);
+    cache->slots[slot].prev = cache->tail;
+    if (cache->tail != -1) cache->slots[cache->tail].next = slot; else cache->head = slot;
+    cache->tail = slot;
+}
+
+// Devuelve una ranura fijada con el bloque en offset, o -1 si la caché está
+// desactivada o todas las ranuras están en uso (el llamador lee directo).
+static StarStatus cache_acquire(StarArchive *archive, size_t offset, int *out) {
+    BlockCache *cache = &archive->cache;
+    *out = -1;
+    if (cache->capacity == 0) {
+        return STAR_OK;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    int slot = cache_find(cache, offset);
+    if (slot != -1) {
+        cache->slots[slot].pins++;
+        cache_push_front(cache, slot);
+        pthread_mutex_unlock(&cache->lock);
+        *out = slot;
+        return STAR_OK;
+    }
+
+    int victim = cache->tail;
+    while (victim != -1 && cache->slots[victim].pins > 0) {
+        victim = cache->slots[victim].prev;
+    }
+    if (victim == -1) {
+        pthread_mutex_unlock(&cache->lock);
+        return STAR_OK;
+    }
+
+    // La víctima queda fijada y fuera de la tabla hash mientras se carga,
+    // así nadie más la ve ni la reutiliza.
+    CacheSlot *s = &cache->slots[victim];
+    cache_hash_remove(cache, victim);
+    s->offset = offset;
+    s->pins = 1;
+    cache_push_front(cache, victim);
+    pthread_mutex_unlock(&cache->lock);
+
+    StarStatus status = STAR_OK;
+    if (s->data == NULL) {
+        s->data = malloc(sizeof(DataBlock));
+        if (s->data == NULL) status = STAR_ERR_NO_MEMORY;
+    }
+    if (status == STAR_OK) {
+        status = read_fully(archive->fd, s->data, sizeof(DataBlock), offset);
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    if (status != STAR_OK) {
+        s->pins = 0;
+        cache_push_back(cache, victim);
+        pthread_mutex_unlock(&cache->lock);
+        return status;
+    }
+    // Otro hilo pudo cargar el mismo bloque en paralelo; en ese caso esta
+    // ranura se usa sólo para esta lectura y se libera al soltarla.
+    if (cache_find(cache, offset) == -1) {
+        cache_hash_insert(cache, victim);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    *out = victim;
+    return STAR_OK;
+}
+
+static void cache_release(BlockCache *cache, int slot) {
+    pthread_mutex_lock(&cache->lock);
+    cache->slots[slot].pins--;
+    if (!cache->slots[slot].valid && cache->slots[slot].pins == 0) {
+        cache_push_back(cache, slot);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// Las escrituras se hacen con fat_lock exclusivo, así que no hay ranuras
+// fijadas cuando se invalida.
+static void cache_invalidate(BlockCache *cache, size_t offset) {
+    if (cache->capacity == 0) return;
+
+    pthread_mutex_lock(&cache->lock);
+    int slot = cache_find(cache, offset);
+    if (slot != -1) {
+        cache_hash_remove(cache, slot);
+        cache_push_back(cache, slot);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+static void cache_clear(BlockCache *cache) {
+    pthread_mutex_lock(&cache->lock);
+    for (size_t i = 0; i < cache->capacity; i++) {
+        cache_hash_remove(cache, (int)i);
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// ---------------------------------------------------------------------------
+// Registro de operaciones
+// ---------------------------------------------------------------------------
+
+// Entrega un mensaje al callback de StarOptions; la biblioteca nunca escribe
+// en stdout ni stderr.
+static void log_message(const StarArchive *archive, const char *format, ...) {
+    if (archive->options.log == NULL) return;
+
+    char message[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    archive->options.log(message, archive->options.log_ctx);
+}
+
+// ---------------------------------------------------------------------------
+// Tabla de asignación y bloques
+// ---------------------------------------------------------------------------
+
+static size_t locate_empty_block(FileAllocationTable *fat) {
+    // Los archivos antiguos pueden tener huecos en cero dentro de la lista
+    while (fat->free_block_count > 0) {
+        size_t free_block = fat->free_block_indices[--fat->free_block_count];
+        if (free_block != 0) {
+            return free_block;
+        }
+    }
+    return NO_BLOCK;
+}
+
+static void release_block(FileAllocationTable *fat, size_t position) {
+    // Si la lista está llena el bloque se recupera en el próximo star_pack
+    if (fat->free_block_count < TOTAL_BLOCKS) {
+        fat->free_block_indices[fat->free_block_count++] = position;
+    }
+}
+
+static StarStatus enlarge_archive(StarArchive *archive) {
+    struct stat st;
+    if (fstat(archive->fd, &st) != 0) {
+        return STAR_ERR_IO;
+    }
+    size_t current_size = (size_t)st.st_size;
+    if (ftruncate(archive->fd, (off_t)(current_size + sizeof(DataBlock))) != 0) {
+        return STAR_ERR_IO;
+    }
+    release_block(&archive->fat, current_size);
+    return STAR_OK;
+}
+
+static StarStatus save_data_block(StarArchive *archive, const DataBlock *block, size_t position) {
+    cache_invalidate(&archive->cache, position);
+    return write_fully(archive->fd, block, sizeof(DataBlock), position);
+}
+
+static StarStatus save_file_table(StarArchive *archive) {
+    return write_fully(archive->fd, &archive->fat, sizeof(FileAllocationTable), 0);
+}
+
+static Entry *find_entry(FileAllocationTable *fat, const char *name) {
+    for (size_t i = 0; i < fat->entry_count; i++) {
+        if (strcmp(fat->entries[i].name, name) == 0) {
+            return &fat->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void fill_entry_info(const Entry *entry, StarEntryInfo *info) {
+    memcpy(info->name, entry->name, sizeof(info->name));
+    info->size = entry->size;
+    memcpy(info->block_indices, entry->block_indices, sizeof(info->block_indices));
+    info->block_count = entry->block_count;
+}
+
+// Devuelve la posición en la rejilla de bloques de offset, o NO_BLOCK si no
+// cae en el inicio de un bloque dentro de limit.
+static size_t block_slot(size_t offset, size_t limit) {
+    if (offset < sizeof(FileAllocationTable) || offset > limit ||
+        (offset - sizeof(FileAllocationTable)) % sizeof(DataBlock) != 0) {
+        return NO_BLOCK;
+    }
+    return (offset - sizeof(FileAllocationTable)) / sizeof(DataBlock);
+}
+
+// Comprueba la tabla leída contra el tamaño real del archivo. Cada bloque
+// debe estar en la rejilla que sigue a la tabla y pertenecer a un solo
+// dueño: una entrada o la lista de libres.
+static StarStatus validate_file_table(const FileAllocationTable *fat, size_t file_size) {
+    if (fat->entry_count > STAR_MAX_ENTRIES || fat->free_block_count > TOTAL_BLOCKS) {
+        return STAR_ERR_FORMAT;
+    }
+
+    // Un bloque libre puede empezar justo al final del archivo
+    size_t slot_count = (file_size - sizeof(FileAllocationTable)) / sizeof(DataBlock) + 1;
+    unsigned char *owners = calloc(slot_count, 1);
+    if (owners == NULL) {
+        return STAR_ERR_NO_MEMORY;
+    }
+
+    StarStatus status = STAR_OK;
+    for (size_t i = 0; i < fat->entry_count && status == STAR_OK; i++) {
+        const Entry *entry = &fat->entries[i];
+        if (entry->block_count > STAR_MAX_BLOCKS_PER_ENTRY ||
+            entry->size > entry->block_count * sizeof(DataBlock) ||
+            memchr(entry->name, '\0', sizeof(entry->name)) == NULL) {
+            status = STAR_ERR_FORMAT;
+            break;
+        }
+        for (size_t k = 0; k < entry->block_count; k++) {
+            size_t slot = (file_size >= sizeof(DataBlock))
+                ? block_slot(entry->block_indices[k], file_size - sizeof(DataBlock))
+                : NO_BLOCK;
+            if (slot == NO_BLOCK || owners[slot]) {
+                status = STAR_ERR_FORMAT;
+                break;
+            }
+            owners[slot] = 1;
+        }
+    }
+
+    for (size_t k = 0; k < fat->free_block_count && status == STAR_OK; k++) {
+        // Los archivos antiguos dejan huecos en cero dentro de la lista
+        if (fat->free_block_indices[k] == 0) continue;
+
+        size_t slot = block_slot(fat->free_block_indices[k], file_size);
+        if (slot == NO_BLOCK || owners[slot]) {
+            status = STAR_ERR_FORMAT;
+            break;
+        }
+        owners[slot] = 1;
+    }
+
+    free(owners);
+    return status;
+}
+
+// Lee input completo a memoria, sin tomar ningún bloqueo del archivo, para
+// que un productor lento (stdin, una tubería) no detenga a los lectores.
+static StarStatus read_input(FILE *input, unsigned char **data, size_t *size) {
+    const size_t limit = STAR_MAX_BLOCKS_PER_ENTRY * sizeof(DataBlock);
+    unsigned char *buffer = NULL;
+    size_t capacity = 0;
+    size_t used = 0;
+    StarStatus status = STAR_OK;
+
+    for (;;) {
+        if (used == capacity) {
+            // Un bloque más allá del límite basta para detectar el exceso
+            if (capacity > limit) {
+                status = STAR_ERR_FULL;
+                break;
+            }
+            unsigned char *grown = realloc(buffer, capacity + sizeof(DataBlock));
+            if (grown == NULL) {
+                status = STAR_ERR_NO_MEMORY;
+                break;
+            }
+            buffer = grown;
+            capacity += sizeof(DataBlock);
+        }
+
+        size_t bytes_read = fread(buffer + used, 1, capacity - used, input);
+        used += bytes_read;
+        if (bytes_read == 0) {
+            if (ferror(input)) status = STAR_ERR_IO;
+            break;
+        }
+    }
+
+    if (status == STAR_OK && used > limit) {
+        status = STAR_ERR_FULL;
+    }
+    if (status != STAR_OK) {
+        free(buffer);
+        return status;
+    }
+    *data = buffer;
+    *size = used;
+    return STAR_OK;
+}
+
+// Copia data a bloques libres y los anota en entry. Si falla, los bloques
+// usados se devuelven a la lista de libres.
+static StarStatus write_data_blocks(StarArchive *archive, const unsigned char *data, size_t size, Entry *entry) {
+    FileAllocationTable *fat = &archive->fat;
+    DataBlock *block = &archive->scratch[0];
+    StarStatus status = STAR_OK;
+
+    entry->size = 0;
+    entry->block_count = 0;
+
+    for (size_t written = 0; written < size; written += sizeof(DataBlock)) {
+        size_t chunk = size - written < sizeof(DataBlock) ? size - written : sizeof(DataBlock);
+
+        size_t block_position = locate_empty_block(fat);
+        if (block_position == NO_BLOCK) {
+            log_message(archive, "Expandiendo el archivo empaquetado por falta de bloques libres.");
+            status = enlarge_archive(archive);
+            if (status != STAR_OK) break;
+            block_position = locate_empty_block(fat);
+        }
+
+        memcpy(block, data + written, chunk);
+        if (chunk < sizeof(DataBlock)) {
+            memset((char*)block + chunk, 0, sizeof(DataBlock) - chunk);
+        }
+
+        entry->block_indices[entry->block_count++] = block_position;
+        status = save_data_block(archive, block, block_position);
+        if (status != STAR_OK) break;
+        entry->size += chunk;
+
+        log_message(archive, "Bloque %zu del archivo '%s' escrito en la posición %zu.", entry->block_count, entry->name, block_position);
+    }
+
+    if (status != STAR_OK) {
+        for (size_t k = 0; k < entry->block_count; k++) {
+            release_block(fat, entry->block_indices[k]);
+        }
+        entry->block_count = 0;
+        entry->size = 0;
+    }
+    return status;
+}
+
+// Comprobación previa con el bloqueo compartido, para no consumir la
+// entrada si la operación no puede hacerse. Se repite al confirmar.
+static bool entry_exists(StarArchive *archive, const char *name) {
+    pthread_rwlock_rdlock(&archive->fat_lock);
+    bool exists = find_entry(&archive->fat, name) != NULL;
+    pthread_rwlock_unlock(&archive->fat_lock);
+    return exists;
+}
+
+// ---------------------------------------------------------------------------
+// API pública
+// ---------------------------------------------------------------------------
+
+void star_default_options(StarOptions *options) {
+    memset(options, 0, sizeof(StarOptions));
+    options->cache_blocks = STAR_DEFAULT_CACHE_BLOCKS;
+}
+
+const char *star_strerror(StarStatus status) {
+    switch (status) {
+        case STAR_OK:            return "Sin error";
+        case STAR_ERR_IO:        return "Error de entrada/salida";
+        case STAR_ERR_FORMAT:    return "El archivo empaquetado está dañado o no es válido";
+        case STAR_ERR_NOT_FOUND: return "Archivo no encontrado en el archivo empaquetado";
+        case STAR_ERR_EXISTS:    return "El archivo ya existe en el archivo empaquetado";
+        case STAR_ERR_FULL:      return "No hay espacio en la tabla de asignación";
+        case STAR_ERR_READ_ONLY: return "El archivo empaquetado se abrió sólo para lectura";
+        case STAR_ERR_INVALID:   return "Argumento inválido";
+        case STAR_ERR_NO_MEMORY: return "Memoria insuficiente";
+        case STAR_ERR_BUSY:      return "El archivo empaquetado está en uso por otro proceso";
+    }
+    return "Error desconocido";
+}
+
+static StarStatus open_archive(const char *path, const StarOptions *options, int flags, StarArchive **out) {
+    if (path == NULL || out == NULL) {
+        return STAR_ERR_INVALID;
+    }
+    *out = NULL;
+
+    StarArchive *archive = calloc(1, sizeof(StarArchive));
+    if (archive == NULL) {
+        return STAR_ERR_NO_MEMORY;
+    }
+    if (options != NULL) {
+        archive->options = *options;
+    } else {
+        star_default_options(&archive->options);
+    }
+    // Las ranuras de la caché se enlazan con índices int
+    if (archive->options.cache_blocks > STAR_MAX_CACHE_BLOCKS) {
+        free(archive);
+        return STAR_ERR_INVALID;
+    }
+    if (flags & O_TRUNC) {
+        archive->options.read_only = false;
+    }
+
+    if (!archive->options.read_only) {
+        archive->scratch = malloc(2 * sizeof(DataBlock));
+        if (archive->scratch == NULL) {
+            free(archive);
+            return STAR_ERR_NO_MEMORY;
+        }
+    }
+
+    // O_TRUNC se aplica después de obtener el bloqueo, para no vaciar un
+    // archivo que otro proceso tiene abierto
+    archive->fd = open(path, (archive->options.read_only ? O_RDONLY : O_RDWR) | (flags & ~O_TRUNC), 0644);
+    if (archive->fd < 0) {
+        free(archive->scratch);
+        free(archive);
+        return STAR_ERR_IO;
+    }
+
+    // La tabla se carga una sola vez y los bloques se guardan en caché, así
+    // que ningún otro proceso puede modificar el archivo mientras esté
+    // abierto: los lectores lo comparten y un escritor lo usa en exclusiva.
+    StarStatus status = STAR_OK;
+    if (flock(archive->fd, (archive->options.read_only ? LOCK_SH : LOCK_EX) | LOCK_NB) != 0) {
+        status = (errno == EWOULDBLOCK) ? STAR_ERR_BUSY : STAR_ERR_IO;
+    } else if ((flags & O_TRUNC) && ftruncate(archive->fd, 0) != 0) {
+        status = STAR_ERR_IO;
+    }
+    if (status != STAR_OK) {
+        close(archive->fd);
+        free(archive->scratch);
+        free(archive);
+        return status;
+    }
+
+    status = cache_init(&archive->cache, archive->options.cache_blocks);
+    if (status != STAR_OK) {
+        close(archive->fd);
+        free(archive->scratch);
+        free(archive);
+        return status;
+    }
+    if (pthread_rwlock_init(&archive->fat_lock, NULL) != 0) {
+        cache_destroy(&archive->cache);
+        close(archive->fd);
+        free(archive->scratch);
+        free(archive);
+        return STAR_ERR_NO_MEMORY;
+    }
+
+    *out = archive;
+    return STAR_OK;
+}
+
+StarStatus star_create(const char *path, const StarOptions *options, StarArchive **out) {
+    StarStatus status = open_archive(path, options, O_CREAT | O_TRUNC, out);
+    if (status != STAR_OK) {
+        return status;
+    }
+
+    // El primer bloque libre empieza justo después de la tabla
+    StarArchive *archive = *out;
+    archive->fat.free_block_indices[0] = sizeof(FileAllocationTable);
+    archive->fat.free_block_count = 1;
+
+    status = save_file_table(archive);
+    if (status != STAR_OK) {
+        star_close(archive);
+        *out = NULL;
+    }
+    return status;
+}
+
+StarStatus star_open(const char *path, const StarOptions *options, StarArchive **out) {
+    StarStatus status = open_archive(path, options, 0, out);
+    if (status != STAR_OK) {
+        return status;
+    }
+
+    StarArchive *archive = *out;
+    struct stat st;
+    if (fstat(archive->fd, &st) != 0) {
+        status = STAR_ERR_IO;
+    } else if ((size_t)st.st_size < sizeof(FileAllocationTable)) {
+        status = STAR_ERR_FORMAT;
+    } else {
+        status = read_fully(archive->fd, &archive->fat, sizeof(FileAllocationTable), 0);
+        if (status == STAR_OK) {
+            status = validate_file_table(&archive->fat, (size_t)st.st_size);
+        }
+    }
+
+    if (status != STAR_OK) {
+        star_close(archive);
+        *out = NULL;
+    }
+    return status;
+}
+
+void star_close(StarArchive *archive) {
+    if (archive == NULL) return;
+
+    pthread_rwlock_destroy(&archive->fat_lock);
+    cache_destroy(&archive->cache);
+    close(archive->fd);
+    free(archive->scratch);
+    free(archive);
+}
+
+StarStatus star_stat(StarArchive *archive, const char *name, StarEntryInfo *info) {
+    if (archive == NULL || name == NULL || info == NULL) {
+        return STAR_ERR_INVALID;
+    }
+
+    pthread_rwlock_rdlock(&archive->fat_lock);
+    Entry *entry = find_entry(&archive->fat, name);
+    if (entry != NULL) {
+        fill_entry_info(entry, info);
+    }
+    pthread_rwlock_unlock(&archive->fat_lock);
+
+    return entry != NULL ? STAR_OK : STAR_ERR_NOT_FOUND;
+}
+
+StarStatus star_iterate(StarArchive *archive, StarIterateFn fn, void *ctx) {
+    if (archive == NULL || fn == NULL) {
+        return STAR_ERR_INVALID;
+    }
+
+    StarEntryInfo info;
+    pthread_rwlock_rdlock(&archive->fat_lock);
+    for (size_t i = 0; i < archive->fat.entry_count; i++) {
+        fill_entry_info(&archive->fat.entries[i], &info);
+        if (fn(&info, ctx) != 0) {
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&archive->fat_lock);
+
+    return STAR_OK;
+}
+
+StarStatus star_read(StarArchive *archive, const char *name, size_t offset,
+                     void *buf, size_t count, size_t *bytes_read) {
+    if (archive == NULL || name == NULL || (buf == NULL && count > 0)) {
+        return STAR_ERR_INVALID;
+    }
+
+    StarStatus status = STAR_OK;
+    size_t total = 0;
+
+    // El bloqueo compartido impide que un star_delete o star_pack
+    // concurrente reutilice los bloques mientras se leen.
+    pthread_rwlock_rdlock(&archive->fat_lock);
+    Entry *entry = find_entry(&archive->fat, name);
+    if (entry == NULL) {
+        status = STAR_ERR_NOT_FOUND;
+    } else if (offset < entry->size) {
+        if (count > entry->size - offset) {
+            count = entry->size - offset;
+        }
+
+        unsigned char *dst = buf;
+        while (total < count) {
+            size_t position = offset + total;
+            size_t block_offset = entry->block_indices[position / sizeof(DataBlock)];
+            size_t within = position % sizeof(DataBlock);
+            size_t chunk = sizeof(DataBlock) - within;
+            if (chunk > count - total) {
+                chunk = count - total;
+            }
+
+            int slot;
+            status = cache_acquire(archive, block_offset, &slot);
+            if (status != STAR_OK) break;
+
+            if (slot != -1) {
+                memcpy(dst + total, archive->cache.slots[slot].data->content + within, chunk);
+                cache_release(&archive->cache, slot);
+            } else {
+                status = read_fully(archive->fd, dst + total, chunk, block_offset + within);
+                if (status != STAR_OK) break;
+            }
+            total += chunk;
+        }
+    }
+    pthread_rwlock_unlock(&archive->fat_lock);
+
+    if (bytes_read != NULL) {
+        *bytes_read = total;
+    }
+    return status;
+}
+
+StarStatus star_append(StarArchive *archive, const char *name, FILE *input) {
+    if (archive == NULL || name == NULL || input == NULL ||
+        strlen(name) >= STAR_MAX_NAME_LENGTH) {
+        return STAR_ERR_INVALID;
+    }
+    if (archive->options.read_only) {
+        return STAR_ERR_READ_ONLY;
+    }
+    if (entry_exists(archive, name)) {
+        return STAR_ERR_EXISTS;
+    }
+
+    unsigned char *data;
+    size_t size;
+    StarStatus status = read_input(input, &data, &size);
+    if (status != STAR_OK) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&archive->fat_lock);
+    FileAllocationTable *fat = &archive->fat;
+
+    if (find_entry(fat, name) != NULL) {
+        status = STAR_ERR_EXISTS;
+    } else if (fat->entry_count == STAR_MAX_ENTRIES) {
+        status = STAR_ERR_FULL;
+    } else {
+        Entry *entry = &fat->entries[fat->entry_count];
+        memset(entry, 0, sizeof(Entry));
+        strcpy(entry->name, name);
+
+        status = write_data_blocks(archive, data, size, entry);
+        if (status == STAR_OK) {
+            fat->entry_count++;
+        }
+        // La tabla se guarda también si falla, para no perder los bloques
+        // que enlarge_archive agregó a la lista de libres.
+        StarStatus save_status = save_file_table(archive);
+        if (status == STAR_OK) {
+            status = save_status;
+        }
+    }
+    pthread_rwlock_unlock(&archive->fat_lock);
+
+    free(data);
+    return status;
+}
+
+StarStatus star_update(StarArchive *archive, const char *name, FILE *input) {
+    if (archive == NULL || name == NULL || input == NULL) {
+        return STAR_ERR_INVALID;
+    }
+    if (archive->options.read_only) {
+        return STAR_ERR_READ_ONLY;
+    }
+    if (!entry_exists(archive, name)) {
+        return STAR_ERR_NOT_FOUND;
+    }
+
+    unsigned char *data;
+    size_t size;
+    StarStatus status = read_input(input, &data, &size);
+    if (status != STAR_OK) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&archive->fat_lock);
+    FileAllocationTable *fat = &archive->fat;
+
+    // La entrada pudo borrarse mientras se leía input
+    Entry *entry = find_entry(fat, name);
+    if (entry == NULL) {
+        status = STAR_ERR_NOT_FOUND;
+    } else {
+        // El contenido nuevo se escribe antes de liberar el anterior para
+        // que un error a mitad de camino no deje la entrada dañada.
+        Entry updated = *entry;
+        status = write_data_blocks(archive, data, size, &updated);
+        if (status == STAR_OK) {
+            for (size_t k = 0; k < entry->block_count; k++) {
+                release_block(fat, entry->block_indices[k]);
+                log_message(archive, "El bloque %zu del archivo '%s' se ha marcado como libre.", entry->block_indices[k], name);
+            }
+            *entry = updated;
+        }
+        StarStatus save_status = save_file_table(archive);
+        if (status == STAR_OK) {
+            status = save_status;
+        }
+    }
+    pthread_rwlock_unlock(&archive->fat_lock);
+
+    free(data);
+    return status;
+}
+
+StarStatus star_delete(StarArchive *archive, const char *name) {
+    if (archive == NULL || name == NULL) {
+        return STAR_ERR_INVALID;
+    }
+    if (archive->options.read_only) {
+        return STAR_ERR_READ_ONLY;
+    }
+
+    pthread_rwlock_wrlock(&archive->fat_lock);
+    FileAllocationTable *fat = &archive->fat;
+    StarStatus status = STAR_OK;
+
+    Entry *entry = find_entry(fat, name);
+    if (entry == NULL) {
+        status = STAR_ERR_NOT_FOUND;
+    } else {
+        // Marcar los bloques como libres
+        for (size_t k = 0; k < entry->block_count; k++) {
+            release_block(fat, entry->block_indices[k]);
+            log_message(archive, "Bloque %zu del archivo '%s' marcado como libre.", entry->block_indices[k], name);
+        }
+
+        // Eliminar la entrada del archivo del FAT
+        size_t j = (size_t)(entry - fat->entries);
+        memmove(&fat->entries[j], &fat->entries[j + 1], (fat->entry_count - j - 1) * sizeof(Entry));
+        fat->entry_count--;
+
+        status = save_file_table(archive);
+    }
+    pthread_rwlock_unlock(&archive->fat_lock);
+
+    return status;
+}
+
+// Escribe block en target y sólo entonces guarda la tabla apuntando ahí. La
+// copia anterior sigue intacta hasta que la tabla ya no la referencia, así
+// que un error en cualquier paso deja cada entrada con un bloque completo.
+static StarStatus move_block(StarArchive *archive, const DataBlock *block, size_t *pointer, size_t target) {
+    StarStatus status = write_fully(archive->fd, block, sizeof(DataBlock), target);
+    if (status != STAR_OK) {
+        return status;
+    }
+    *pointer = target;
+    return save_file_table(archive);
+}
+
+StarStatus star_pack(StarArchive *archive) {
+    if (archive == NULL) {
+        return STAR_ERR_INVALID;
+    }
+    if (archive->options.read_only) {
+        return STAR_ERR_READ_ONLY;
+    }
+
+    pthread_rwlock_wrlock(&archive->fat_lock);
+    FileAllocationTable *fat = &archive->fat;
+    DataBlock *moving = &archive->scratch[0];
+    DataBlock *displaced = &archive->scratch[1];
+    StarStatus status = STAR_OK;
+
+    // La lista de libres se descarta antes de mover nada: si la
+    // desfragmentación se interrumpe, ningún bloque usado figura como libre
+    // y las escrituras siguientes agrandarán el archivo.
+    memset(fat->free_block_indices, 0, sizeof(fat->free_block_indices));
+    fat->free_block_count = 0;
+    status = save_file_table(archive);
+
+    // Ranura auxiliar al final del archivo, fuera de todo bloque usado,
+    // donde se aparta el bloque desplazado durante un intercambio
+    struct stat st;
+    size_t spare = sizeof(FileAllocationTable);
+    if (status == STAR_OK && fstat(archive->fd, &st) != 0) {
+        status = STAR_ERR_IO;
+    } else if (status == STAR_OK && (size_t)st.st_size > spare) {
+        size_t data_size = (size_t)st.st_size - sizeof(FileAllocationTable);
+        spare += (data_size + sizeof(DataBlock) - 1) / sizeof(DataBlock) * sizeof(DataBlock);
+    }
+
+    size_t new_block_position = sizeof(FileAllocationTable);  // Nueva posición de inicio para los bloques
+    for (size_t i = 0; i < fat->entry_count && status == STAR_OK; i++) {
+        Entry *entry = &fat->entries[i];
+
+        for (size_t j = 0; j < entry->block_count && status == STAR_OK; j++) {
+            size_t source = entry->block_indices[j];
+            if (source != new_block_position) {
+                // Si el destino lo ocupa un bloque que aún no se ha movido,
+                // se aparta en la ranura auxiliar y luego ocupa el lugar
+                // que deja el bloque movido.
+                size_t *occupant = NULL;
+                for (size_t k = i; k < fat->entry_count && occupant == NULL; k++) {
+                    for (size_t l = (k == i) ? j + 1 : 0; l < fat->entries[k].block_count; l++) {
+                        if (fat->entries[k].block_indices[l] == new_block_position) {
+                            occupant = &fat->entries[k].block_indices[l];
+                            break;
+                        }
+                    }
+                }
+
+                if (occupant != NULL) {
+                    status = read_fully(archive->fd, displaced, sizeof(DataBlock), new_block_position);
+                    if (status == STAR_OK) status = move_block(archive, displaced, occupant, spare);
+                }
+                if (status == STAR_OK) status = read_fully(archive->fd, moving, sizeof(DataBlock), source);
+                if (status == STAR_OK) status = move_block(archive, moving, &entry->block_indices[j], new_block_position);
+                if (status == STAR_OK && occupant != NULL) {
+                    status = move_block(archive, displaced, occupant, source);
+                }
+                if (status != STAR_OK) break;
+
+                log_message(archive, "El bloque %zu del archivo '%s' se ha movido a la posición %zu.", j + 1, entry->name, new_block_position);
+            }
+            new_block_position += sizeof(DataBlock);
+        }
+    }
+
+    // Tras compactar el único bloque libre es el que sigue al último usado
+    if (status == STAR_OK) {
+        fat->free_block_indices[fat->free_block_count++] = new_block_position;
+        status = save_file_table(archive);
+    }
+    if (status == STAR_OK && ftruncate(archive->fd, (off_t)new_block_position) != 0) {
+        status = STAR_ERR_IO;
+    }
+    cache_clear(&archive->cache);
+    pthread_rwlock_unlock(&archive->fat_lock);
+
+    return status;
+}
@@ -0,0 +1,88 @@
+#ifndef STARPACK_H
+#define STARPACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Parámetros del formato en disco (deben coincidir con archivos ya creados)
+#define STAR_BLOCK_SIZE (256 * 1024) // 256 KB
+#define STAR_MAX_ENTRIES 100
+#define STAR_MAX_NAME_LENGTH 256
+#define STAR_MAX_BLOCKS_PER_ENTRY 64
+
+// Cantidad de bloques que guarda la caché LRU si no se indica otra cosa
+#define STAR_DEFAULT_CACHE_BLOCKS 16
+// Límite de cache_blocks (16 GB de bloques); valores mayores son inválidos
+#define STAR_MAX_CACHE_BLOCKS 65536
+
+typedef enum {
+    STAR_OK = 0,
+    STAR_ERR_IO,
+    STAR_ERR_FORMAT,
+    STAR_ERR_NOT_FOUND,
+    STAR_ERR_EXISTS,
+    STAR_ERR_FULL,
+    STAR_ERR_READ_ONLY,
+    STAR_ERR_INVALID,
+    STAR_ERR_NO_MEMORY,
+    STAR_ERR_BUSY
+} StarStatus;
+
+// Manejador opaco de un archivo empaquetado abierto
+typedef struct StarArchive StarArchive;
+
+typedef struct {
+    size_t cache_blocks; // Capacidad de la caché de bloques (0 la desactiva)
+    bool read_only;      // Abre el archivo sólo para lectura
+    // Recibe el detalle de cada bloque escrito, movido o liberado (opcional).
+    // Se llama con el archivo bloqueado: no debe usar el mismo StarArchive.
+    void (*log)(const char *message, void *ctx);
+    void *log_ctx;
+} StarOptions;
+
+typedef struct {
+    char name[STAR_MAX_NAME_LENGTH];
+    size_t size;
+    size_t block_indices[STAR_MAX_BLOCKS_PER_ENTRY];
+    size_t block_count;
+} StarEntryInfo;
+
+// Devuelve distinto de cero para detener la iteración
+typedef int (*StarIterateFn)(const StarEntryInfo *info, void *ctx);
+
+void star_default_options(StarOptions *options);
+const char *star_strerror(StarStatus status);
+
+// Un manejador abierto toma un flock sobre el archivo: compartido si es de
+// sólo lectura, exclusivo si puede escribir. Si otro manejador (de este u
+// otro proceso, como el comando star) lo impide, se devuelve STAR_ERR_BUSY
+// en lugar de esperar. Varios hilos deben compartir un mismo manejador.
+
+// Crea (o trunca) un archivo empaquetado vacío y lo deja abierto
+StarStatus star_create(const char *path, const StarOptions *options, StarArchive **out);
+// Abre un archivo existente; la tabla FAT se carga una sola vez
+StarStatus star_open(const char *path, const StarOptions *options, StarArchive **out);
+void star_close(StarArchive *archive);
+
+// Las funciones siguientes se pueden llamar desde varios hilos sobre el
+// mismo StarArchive. Las lecturas se ejecutan en paralelo; las
+// modificaciones son exclusivas.
+
+StarStatus star_stat(StarArchive *archive, const char *name, StarEntryInfo *info);
+// El callback no debe llamar funciones que modifiquen el mismo archivo
+StarStatus star_iterate(StarArchive *archive, StarIterateFn fn, void *ctx);
+// Lee hasta count bytes de name a partir de offset, al estilo de pread
+StarStatus star_read(StarArchive *archive, const char *name, size_t offset,
+                     void *buf, size_t count, size_t *bytes_read);
+
+// Leen input completo a memoria (hasta STAR_MAX_BLOCKS_PER_ENTRY bloques)
+// antes de tomar el bloqueo exclusivo, así una entrada lenta no detiene a
+// los lectores concurrentes
+StarStatus star_append(StarArchive *archive, const char *name, FILE *input);
+StarStatus star_update(StarArchive *archive, const char *name, FILE *input);
+StarStatus star_delete(StarArchive *archive, const char *name);
+// Desfragmenta el archivo sin usar archivos temporales
+StarStatus star_pack(StarArchive *archive);
+
+#endif